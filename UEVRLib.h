@@ -7,6 +7,7 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <algorithm>
 
 // adapted from lua uevrlib, mostly 
 // AI generated as an experiment to see if this would even be viable. Use at your own risk. Compiler caught nothing wrong but its untested
@@ -629,17 +630,421 @@ inline void resetAnimation(const std::string& animID, const std::string& animNam
     animStates[animID][animName] = isPressed;
 }
 
-// Visualization helpers (stub, as these require engine-specific mesh/component logic)
+// -------------------- SKELETAL VISUALIZATION --------------------
+// Renders a sphere at every bone joint of one or more skeletons through a single
+// InstancedStaticMeshComponent. Each registered skeleton owns a contiguous block of
+// instances and only the span of bones that moved since the last update is re-sent,
+// in a single BatchUpdateInstancesTransforms call per skeleton.
+// Params structs use the float (UE4) layouts; every UFunction is checked against them
+// before use so other layouts are rejected instead of overrunning the stack.
+class SkeletalVisualizer {
+public:
+    struct Vector3f {
+        float x, y, z;
+    };
+
+    struct alignas(16) InstanceTransform {
+        float rotation[4]{ 0, 0, 0, 1 };
+        float translation[3]{ 0, 0, 0 };
+        float pad0{ 0 };
+        float scale3d[3]{ 1, 1, 1 };
+        float pad1{ 0 };
+    };
+
+    // Non-owning TArray layout used to pass a std::vector to process_event without
+    // handing the buffer to the engine allocator
+    template <typename T>
+    struct TArrayView {
+        T* data;
+        int32_t count;
+        int32_t capacity;
+    };
+
+    bool addSkeleton(API::UObject* skeletalMeshComponent, float scale) {
+        if (!validate_object(skeletalMeshComponent)) {
+            animation_print("SkeletalMeshComponent was not valid in createSkeletalVisualization", LogLevel::Warning);
+            return false;
+        }
+        if (!ensureComponent()) return false;
+
+        auto skeletalClass = skeletalMeshComponent->get_class();
+        auto getNumBonesFn = skeletalClass->find_function(L"GetNumBones");
+        auto getBoneNameFn = skeletalClass->find_function(L"GetBoneName");
+        auto getLocationFn = skeletalClass->find_function(L"GetBoneLocationByName");
+        if (!checkParams<GetNumBonesParams>(getNumBonesFn, "GetNumBones") ||
+            !checkParams<GetBoneNameParams>(getBoneNameFn, "GetBoneName") ||
+            !checkParams<GetBoneLocationParams>(getLocationFn, "GetBoneLocationByName")) {
+            return false;
+        }
+
+        GetNumBonesParams numParams{ 0 };
+        skeletalMeshComponent->process_event(getNumBonesFn, &numParams);
+        int32_t count = numParams.ReturnValue;
+        if (count <= 0) return false;
+
+        animation_print("Creating Skeletal Visualization with " + std::to_string(count) + " bones", LogLevel::Info);
+
+        std::vector<API::FName> boneNames;
+        boneNames.reserve(count);
+        for (int32_t index = 0; index < count; ++index) {
+            GetBoneNameParams nameParams{ index, {} };
+            skeletalMeshComponent->process_event(getBoneNameFn, &nameParams);
+            boneNames.push_back(nameParams.ReturnValue);
+        }
+
+        // Re-registering may follow SetSkeletalMesh or a new component allocated at a destroyed
+        // one's address, so the bones are always re-read and only the instance block is kept
+        int32_t firstInstance = -1;
+        int32_t blockCount = count;
+        auto existing = skeletons_.find(skeletalMeshComponent);
+        if (existing != skeletons_.end()) {
+            if (existing->second.blockCount >= count) {
+                firstInstance = existing->second.firstInstance;
+                blockCount = existing->second.blockCount;
+                hideInstances(firstInstance + count, blockCount - count);
+                skeletons_.erase(existing);
+            }
+            else {
+                releaseSkeleton(existing);
+            }
+        }
+        if (firstInstance < 0) {
+            firstInstance = allocateInstances(count, scale);
+            if (firstInstance < 0) return false;
+        }
+
+        Skeleton skeleton;
+        skeleton.skeletalClass = skeletalClass;
+        skeleton.getLocationFn = getLocationFn;
+        skeleton.firstInstance = firstInstance;
+        skeleton.blockCount = blockCount;
+        skeleton.boneNames = std::move(boneNames);
+        skeleton.lastLocations.assign(count, Vector3f{ 0, 0, 0 });
+        skeleton.scales.assign(count, scale);
+        skeleton.dirty.assign(count, true);
+        skeletons_[skeletalMeshComponent] = std::move(skeleton);
+        return true;
+    }
+
+    // Hides the skeleton's instances and keeps its block for reuse by a later skeleton
+    void removeSkeleton(API::UObject* skeletalMeshComponent) {
+        auto it = skeletons_.find(skeletalMeshComponent);
+        if (it != skeletons_.end()) releaseSkeleton(it);
+    }
+
+    // call on the tick to do the actual position update
+    void update(API::UObject* skeletalMeshComponent) {
+        auto it = skeletons_.find(skeletalMeshComponent);
+        if (it == skeletons_.end()) return;
+        if (!validate_object(component_)) {
+            skeletons_.clear();
+            freeBlocks_.clear();
+            return;
+        }
+        // validate_object only proves some object lives at this address, so make sure it is
+        // still the class the cached function was resolved on
+        if (!validate_object(skeletalMeshComponent) || skeletalMeshComponent->get_class() != it->second.skeletalClass) {
+            releaseSkeleton(it);
+            return;
+        }
+        auto& skeleton = it->second;
+
+        const size_t count = skeleton.boneNames.size();
+        for (size_t index = 0; index < count; ++index) {
+            GetBoneLocationParams params{ skeleton.boneNames[index], 0, {} };
+            skeletalMeshComponent->process_event(skeleton.getLocationFn, &params);
+            const auto& last = skeleton.lastLocations[index];
+            float dx = params.ReturnValue.x - last.x;
+            float dy = params.ReturnValue.y - last.y;
+            float dz = params.ReturnValue.z - last.z;
+            if (dx * dx + dy * dy + dz * dz > kMoveThresholdSq) {
+                skeleton.lastLocations[index] = params.ReturnValue;
+                skeleton.dirty[index] = true;
+            }
+        }
+
+        // Send one span from the first to the last moved bone; re-sending a few unchanged
+        // transforms in between is cheaper than an extra ProcessEvent call per gap
+        size_t firstDirty = count;
+        size_t lastDirty = 0;
+        for (size_t index = 0; index < count; ++index) {
+            if (!skeleton.dirty[index]) continue;
+            if (firstDirty == count) firstDirty = index;
+            lastDirty = index;
+        }
+        if (firstDirty == count) return;
+
+        scratch_.clear();
+        for (size_t index = firstDirty; index <= lastDirty; ++index) {
+            InstanceTransform transform;
+            transform.translation[0] = skeleton.lastLocations[index].x;
+            transform.translation[1] = skeleton.lastLocations[index].y;
+            transform.translation[2] = skeleton.lastLocations[index].z;
+            transform.scale3d[0] = transform.scale3d[1] = transform.scale3d[2] = skeleton.scales[index];
+            scratch_.push_back(transform);
+            skeleton.dirty[index] = false;
+        }
+        batchUpdate(skeleton.firstInstance + static_cast<int32_t>(firstDirty));
+    }
+
+    // scale a specific sphere in the hierarchy to a larger size and print that bone's name
+    void setBoneScale(API::UObject* skeletalMeshComponent, int index, float scale) {
+        if (!validate_object(skeletalMeshComponent)) return;
+        auto it = skeletons_.find(skeletalMeshComponent);
+        if (it == skeletons_.end()) return;
+        auto& skeleton = it->second;
+        int count = static_cast<int>(skeleton.boneNames.size());
+        if (index < 0) index = 0;
+        if (index >= count) index = count - 1;
+        auto boneName = skeleton.boneNames[index].to_string();
+        API::get()->log_info("[animation] Visualizing %d %ls", index, boneName.c_str());
+        skeleton.scales[index] = scale;
+        skeleton.dirty[index] = true;
+    }
+
+    // Destroys the visualization actor along with all instances
+    void clear() {
+        destroyActor();
+        component_ = nullptr;
+        batchUpdateFn_ = nullptr;
+        addInstanceFn_ = nullptr;
+        removeInstanceFn_ = nullptr;
+        skeletons_.clear();
+        freeBlocks_.clear();
+    }
+
+private:
+    struct Skeleton {
+        int32_t firstInstance = -1;
+        int32_t blockCount = 0;
+        API::UClass* skeletalClass = nullptr;
+        API::UFunction* getLocationFn = nullptr;
+        std::vector<API::FName> boneNames;
+        std::vector<Vector3f> lastLocations;
+        std::vector<float> scales;
+        std::vector<bool> dirty;
+    };
+
+    struct InstanceBlock {
+        int32_t first;
+        int32_t count;
+    };
+
+    struct AddComponentByClassParams {
+        API::UClass* Class;
+        bool bManualAttachment;
+        InstanceTransform RelativeTransform;
+        bool bDeferredFinish;
+        API::UObject* ReturnValue;
+    };
+    struct SetStaticMeshParams { API::UObject* NewMesh; bool ReturnValue; };
+    struct SetVisibilityParams { bool bNewVisibility; bool bPropagateToChildren; };
+    struct SetHiddenInGameParams { bool NewHidden; bool bPropagateToChildren; };
+    struct SetCollisionEnabledParams { uint8_t NewType; };
+    struct GetNumBonesParams { int32_t ReturnValue; };
+    struct GetBoneNameParams { int32_t BoneIndex; API::FName ReturnValue; };
+    struct GetBoneLocationParams { API::FName BoneName; uint8_t BoneSpace; Vector3f ReturnValue; };
+    struct AddInstanceParams { InstanceTransform Transform; int32_t ReturnValue; };
+    struct RemoveInstanceParams { int32_t InstanceIndex; bool ReturnValue; };
+    struct BatchUpdateParams {
+        int32_t StartInstanceIndex;
+        TArrayView<InstanceTransform> NewInstancesTransforms;
+        bool bWorldSpace;
+        bool bMarkRenderStateDirty;
+        bool bTeleport;
+        bool ReturnValue;
+    };
+
+    static constexpr float kMoveThresholdSq = 0.0001f;
+
+    // The engine params block may only differ from ours by tail padding
+    template <typename Params>
+    static bool checkParams(API::UFunction* fn, const char* name) {
+        if (!fn) {
+            animation_print(std::string("Function not found: ") + name, LogLevel::Error);
+            return false;
+        }
+        auto size = static_cast<size_t>(fn->get_properties_size());
+        if (size > sizeof(Params) || size + alignof(Params) <= sizeof(Params)) {
+            animation_print(std::string("Unexpected params size for ") + name + ": " + std::to_string(size) +
+                " (expected " + std::to_string(sizeof(Params)) + ")", LogLevel::Error);
+            return false;
+        }
+        return true;
+    }
+
+    bool ensureComponent() {
+        if (validate_object(component_)) return true;
+        // Old instances died with the component (e.g. on level change)
+        clear();
+
+        auto compClass = API::get()->find_uobject<API::UClass>(L"Class /Script/Engine.InstancedStaticMeshComponent");
+        if (!compClass) {
+            animation_print("InstancedStaticMeshComponent class not found", LogLevel::Error);
+            return false;
+        }
+        actor_ = spawn_actor(get_transform().get(), 1, nullptr);
+        if (!actor_) {
+            animation_print("InstancedStaticMeshComponent not created", LogLevel::Error);
+            return false;
+        }
+        auto addCompFn = actor_->get_class()->find_function(L"AddComponentByClass");
+        if (!checkParams<AddComponentByClassParams>(addCompFn, "AddComponentByClass")) {
+            destroyActor();
+            return false;
+        }
+        AddComponentByClassParams params{ compClass, true, InstanceTransform{}, false, nullptr };
+        actor_->process_event(addCompFn, &params);
+        if (!params.ReturnValue) {
+            animation_print("InstancedStaticMeshComponent not created", LogLevel::Error);
+            destroyActor();
+            return false;
+        }
+        auto compFnClass = params.ReturnValue->get_class();
+        auto addInstanceFn = compFnClass->find_function(L"AddInstance");
+        auto removeInstanceFn = compFnClass->find_function(L"RemoveInstance");
+        auto batchUpdateFn = compFnClass->find_function(L"BatchUpdateInstancesTransforms");
+        if (!checkParams<AddInstanceParams>(addInstanceFn, "AddInstance") ||
+            !checkParams<RemoveInstanceParams>(removeInstanceFn, "RemoveInstance") ||
+            !checkParams<BatchUpdateParams>(batchUpdateFn, "BatchUpdateInstancesTransforms")) {
+            destroyActor();
+            return false;
+        }
+        component_ = params.ReturnValue;
+        addInstanceFn_ = addInstanceFn;
+        removeInstanceFn_ = removeInstanceFn;
+        batchUpdateFn_ = batchUpdateFn;
+
+        auto staticMesh = find_instance_of(L"Class /Script/Engine.StaticMesh", L"StaticMesh /Engine/EngineMeshes/Sphere.Sphere");
+        auto setMeshFn = compFnClass->find_function(L"SetStaticMesh");
+        if (staticMesh && checkParams<SetStaticMeshParams>(setMeshFn, "SetStaticMesh")) {
+            SetStaticMeshParams meshParams{ staticMesh, false };
+            component_->process_event(setMeshFn, &meshParams);
+        }
+        else {
+            animation_print("Static Mesh not found", LogLevel::Warning);
+        }
+
+        // Same setup as create_component_of_class in uevr_utils.lua
+        auto visibilityFn = compFnClass->find_function(L"SetVisibility");
+        if (checkParams<SetVisibilityParams>(visibilityFn, "SetVisibility")) {
+            SetVisibilityParams visibilityParams{ true, false };
+            component_->process_event(visibilityFn, &visibilityParams);
+        }
+        auto hiddenFn = compFnClass->find_function(L"SetHiddenInGame");
+        if (checkParams<SetHiddenInGameParams>(hiddenFn, "SetHiddenInGame")) {
+            SetHiddenInGameParams hiddenParams{ false, false };
+            component_->process_event(hiddenFn, &hiddenParams);
+        }
+        auto collisionFn = compFnClass->find_function(L"SetCollisionEnabled");
+        if (checkParams<SetCollisionEnabledParams>(collisionFn, "SetCollisionEnabled")) {
+            SetCollisionEnabledParams collisionParams{ 0 };
+            component_->process_event(collisionFn, &collisionParams);
+        }
+        return true;
+    }
+
+    void destroyActor() {
+        if (validate_object(actor_)) {
+            auto destroyFn = actor_->get_class()->find_function(L"K2_DestroyActor");
+            if (destroyFn) {
+                actor_->process_event(destroyFn, nullptr);
+            }
+        }
+        actor_ = nullptr;
+    }
+
+    // Returns the first index of a contiguous block of count instances, or -1
+    int32_t allocateInstances(int32_t count, float scale) {
+        for (size_t i = 0; i < freeBlocks_.size(); ++i) {
+            auto block = freeBlocks_[i];
+            if (block.count < count) continue;
+            freeBlocks_.erase(freeBlocks_.begin() + i);
+            if (block.count > count) {
+                freeBlocks_.push_back(InstanceBlock{ block.first + count, block.count - count });
+            }
+            return block.first;
+        }
+
+        InstanceTransform transform;
+        transform.scale3d[0] = transform.scale3d[1] = transform.scale3d[2] = scale;
+        std::vector<int32_t> added;
+        added.reserve(count);
+        for (int32_t index = 0; index < count; ++index) {
+            AddInstanceParams addParams{ transform, -1 };
+            component_->process_event(addInstanceFn_, &addParams);
+            if (addParams.ReturnValue >= 0) added.push_back(addParams.ReturnValue);
+            if (addParams.ReturnValue < 0 || addParams.ReturnValue != added.front() + index) {
+                animation_print("AddInstance returned a non-contiguous index, rolling back", LogLevel::Error);
+                for (auto it = added.rbegin(); it != added.rend(); ++it) {
+                    RemoveInstanceParams removeParams{ *it, false };
+                    component_->process_event(removeInstanceFn_, &removeParams);
+                }
+                return -1;
+            }
+        }
+        return added.front();
+    }
+
+    void releaseSkeleton(std::unordered_map<API::UObject*, Skeleton>::iterator it) {
+        auto& skeleton = it->second;
+        if (validate_object(component_) && skeleton.blockCount > 0) {
+            hideInstances(skeleton.firstInstance, skeleton.blockCount);
+            freeBlocks_.push_back(InstanceBlock{ skeleton.firstInstance, skeleton.blockCount });
+        }
+        skeletons_.erase(it);
+    }
+
+    // Collapses count instances starting at first to zero scale
+    void hideInstances(int32_t first, int32_t count) {
+        if (count <= 0) return;
+        InstanceTransform hidden;
+        hidden.scale3d[0] = hidden.scale3d[1] = hidden.scale3d[2] = 0.0f;
+        scratch_.assign(count, hidden);
+        batchUpdate(first);
+    }
+
+    // Sends scratch_ to the instances starting at startIndex
+    void batchUpdate(int32_t startIndex) {
+        BatchUpdateParams params{
+            startIndex,
+            { scratch_.data(), static_cast<int32_t>(scratch_.size()), static_cast<int32_t>(scratch_.size()) },
+            true, true, true, false
+        };
+        component_->process_event(batchUpdateFn_, &params);
+    }
+
+    API::UObject* actor_ = nullptr;
+    API::UObject* component_ = nullptr;
+    API::UFunction* addInstanceFn_ = nullptr;
+    API::UFunction* removeInstanceFn_ = nullptr;
+    API::UFunction* batchUpdateFn_ = nullptr;
+    std::unordered_map<API::UObject*, Skeleton> skeletons_;
+    std::vector<InstanceBlock> freeBlocks_;
+    std::vector<InstanceTransform> scratch_;
+};
+
+inline SkeletalVisualizer skeletalVisualizer;
+
+// creates a sphere instance at each bone joint in order to visualize the bone hierarchy
 inline void createSkeletalVisualization(API::UObject* skeletalMeshComponent, float scale = 0.003f) {
-    // Implement visualization logic as needed
+    skeletalVisualizer.addSkeleton(skeletalMeshComponent, scale);
 }
 
 inline void updateSkeletalVisualization(API::UObject* skeletalMeshComponent) {
-    // Implement visualization update logic as needed
+    skeletalVisualizer.update(skeletalMeshComponent);
 }
 
 inline void setSkeletalVisualizationBoneScale(API::UObject* skeletalMeshComponent, int index, float scale) {
-    // Implement visualization scale logic as needed
+    skeletalVisualizer.setBoneScale(skeletalMeshComponent, index, scale);
+}
+
+inline void removeSkeletalVisualization(API::UObject* skeletalMeshComponent) {
+    skeletalVisualizer.removeSkeleton(skeletalMeshComponent);
+}
+
+inline void clearSkeletalVisualization() {
+    skeletalVisualizer.clear();
 }
 
 